@@ -0,0 +1,193 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "analyzer.hpp"
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace spintax {
+
+namespace {
+
+//! Maximum length of the group text printed in a report.
+const size_t MAX_REPORT_TEXT = 40;
+
+}
+
+Analyzer::Analyzer(const Structure& structure)
+    :m_numPermutations(numPermutations(structure.topLevelTokens()))
+{
+    m_histogram = analyze(structure.topLevelTokens(), 0, m_numPermutations);
+}
+
+long double Analyzer::numPermutations(const TokVec& tokens) {
+    long double result(1);
+    for (auto token : tokens) {
+        const std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            long double perGroup(0);
+            for (auto variant : group->variants()) {
+                perGroup += numPermutations(variant->tokens());
+            }
+            result *= perGroup;
+        }
+    }
+    return result;
+}
+
+LengthHistogram Analyzer::analyze(const TokVec& tokens, unsigned depth, long double lines) {
+    LengthHistogram result(1, 1);
+    for (auto token : tokens) {
+        const std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            GroupStats stats;
+            stats.depth = depth;
+            stats.text = group->spintaxStr();
+            stats.numVariants = group->numVariants();
+            stats.permutations = numPermutations(TokVec(1, token));
+            stats.lines = lines;
+            m_groups.push_back(stats);
+
+            // Each permutation of the group is used by the same number of lines.
+            const long double linesPerPermutation(lines / stats.permutations);
+            LengthHistogram perGroup;
+            for (auto variant : group->variants()) {
+                LengthHistogram perVariant(analyze(variant->tokens(), depth + 1,
+                        linesPerPermutation * numPermutations(variant->tokens())));
+                if (perVariant.size() > perGroup.size()) {
+                    perGroup.resize(perVariant.size(), 0);
+                }
+                for (size_t i=0; i<perVariant.size(); ++i) {
+                    perGroup[i] += perVariant[i];
+                }
+            }
+            convolve(result, perGroup);
+        } else {
+            result.insert(result.begin(), token->str().length(), 0);
+        }
+    }
+    return result;
+}
+
+void Analyzer::convolve(LengthHistogram& res, const LengthHistogram& other) const {
+    LengthHistogram result(res.size() + other.size() - 1, 0);
+    for (size_t i=0; i<res.size(); ++i) {
+        if (res[i] == 0) {
+            continue;
+        }
+        for (size_t j=0; j<other.size(); ++j) {
+            result[i + j] += res[i] * other[j];
+        }
+    }
+    res.swap(result);
+}
+
+const LengthHistogram& Analyzer::histogram() const {
+    return m_histogram;
+}
+
+const std::vector<GroupStats>& Analyzer::groups() const {
+    return m_groups;
+}
+
+long double Analyzer::numPermutations() const {
+    return m_numPermutations;
+}
+
+size_t Analyzer::minLength() const {
+    size_t length(0);
+    while (length + 1 < m_histogram.size() && m_histogram[length] == 0) {
+        ++length;
+    }
+    return length;
+}
+
+size_t Analyzer::maxLength() const {
+    return m_histogram.size() - 1;
+}
+
+double Analyzer::meanLength() const {
+    long double sum(0);
+    for (size_t i=0; i<m_histogram.size(); ++i) {
+        sum += m_histogram[i] * i;
+    }
+    return sum / m_numPermutations;
+}
+
+size_t Analyzer::percentile(double percent) const {
+    const long double threshold(m_numPermutations * percent / 100);
+    long double cumulative(0);
+    for (size_t i=0; i<m_histogram.size(); ++i) {
+        cumulative += m_histogram[i];
+        if (m_histogram[i] != 0 && cumulative >= threshold) {
+            return i;
+        }
+    }
+    return maxLength();
+}
+
+std::string Analyzer::countStr(long double count) {
+    std::ostringstream result;
+    if (count <= std::ldexp(1.0L, 64)) {
+        result << std::fixed << std::setprecision(0) << count;
+    } else {
+        result << std::scientific << std::setprecision(6) << count;
+    }
+    return result.str();
+}
+
+void Analyzer::writeReport(std::ostream& out) const {
+    out << "permutations: " << countStr(m_numPermutations) << "\n";
+    out << "length min: " << minLength() << "\n";
+    out << "length max: " << maxLength() << "\n";
+    out << "length mean: " << meanLength() << "\n";
+    const double percents[] = { 50, 90, 99 };
+    for (auto p : percents) {
+        out << "length p" << p << ": " << percentile(p) << "\n";
+    }
+
+    out << "length histogram:\n";
+    for (size_t i=0; i<m_histogram.size(); ++i) {
+        if (m_histogram[i] != 0) {
+            out << "  " << i << ": " << countStr(m_histogram[i]) << "\n";
+        }
+    }
+
+    out << "groups:\n";
+    for (auto& g : m_groups) {
+        std::string text(g.text);
+        if (text.length() > MAX_REPORT_TEXT) {
+            text = text.substr(0, MAX_REPORT_TEXT - 3) + "...";
+        }
+        out << std::string(2 * g.depth + 2, ' ') << "G: '" << text << "'"
+            << " variants: " << g.numVariants
+            << " permutations: " << countStr(g.permutations)
+            << " lines: " << countStr(g.lines) << "\n";
+    }
+}
+
+}
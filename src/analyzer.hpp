@@ -0,0 +1,101 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef ANALYZER_HPP
+#define ANALYZER_HPP
+
+#include "spintax.hpp"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace spintax {
+
+//! Number of permutations of each length (the index is the length).
+typedef std::vector<long double> LengthHistogram;
+
+//! Statistics of a single Group gathered by Analyzer.
+struct GroupStats {
+    //! Nesting level (0 for top level groups).
+    unsigned    depth;
+    //! Spintax text of the group, to help identifying it.
+    std::string text;
+    unsigned    numVariants;
+    //! Number of permutations of the group itself.
+    long double permutations;
+    //! Number of output lines the group contributes to.
+    long double lines;
+};
+
+//! Spintax structure analyzer.
+/*!
+ * Computes the exact distribution of output line lengths of a Structure
+ * without generating the permutations. Length histograms of the tokens
+ * of a Variant are convolved and histograms of the variants of a Group
+ * are summed, so the cost depends on the template size only (no output
+ * line is longer than the template).
+ *
+ * Lengths are measured in bytes. Counts are kept as long double, so that
+ * templates with any number of permutations can be analyzed: they are
+ * exact up to 2^64 permutations and rounded (never wrapped) above that.
+ * \sa Structure
+ */
+class Analyzer {
+    LengthHistogram         m_histogram;
+    std::vector<GroupStats> m_groups;
+    long double             m_numPermutations;
+
+    //! Returns the length histogram of tokens, which are part of lines output lines.
+    LengthHistogram analyze(const TokVec& tokens, unsigned depth, long double lines);
+    //! Returns the number of permutations of tokens.
+    static long double numPermutations(const TokVec& tokens);
+    //! Returns count as an integer, or in scientific notation if it may be rounded.
+    static std::string countStr(long double count);
+    //! Convolves res with other.
+    void convolve(LengthHistogram& res, const LengthHistogram& other) const;
+
+public:
+    explicit Analyzer(const Structure& structure);
+
+    //! Returns the length histogram of all permutations.
+    const LengthHistogram& histogram() const;
+    //! Returns statistics of all groups, in order of appearance.
+    const std::vector<GroupStats>& groups() const;
+
+    long double numPermutations() const;
+    size_t minLength() const;
+    size_t maxLength() const;
+    double meanLength() const;
+    //! Returns the smallest length not exceeded by at least percent % of permutations.
+    size_t percentile(double percent) const;
+
+    //! Write a human readable report to the provided output stream.
+    void writeReport(std::ostream& out=std::cout) const;
+};
+
+}
+
+#endif /* ANALYZER_HPP */
@@ -0,0 +1,208 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "delta.hpp"
+
+namespace spintax {
+
+Delta::Delta(const Structure& from, const Structure& to)
+    :m_from(from), m_to(to), m_fromMatcher(m_from), m_toMatcher(m_to)
+{
+}
+
+std::vector<Delta::Unit> Delta::units(const TokVec& tokens) {
+    std::vector<Unit> result;
+    for (auto token : tokens) {
+        const std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            Unit unit;
+            unit.group = group;
+            result.push_back(unit);
+        } else if (!result.empty() && !result.back().group) {
+            result.back().text += token->str();
+        } else {
+            Unit unit;
+            unit.text = token->str();
+            result.push_back(unit);
+        }
+    }
+    return result;
+}
+
+bool Delta::alignable(const std::vector<Unit>& units, const std::vector<Unit>& other) {
+    if (units.size() != other.size()) {
+        return false;
+    }
+    for (size_t i=0; i<units.size(); ++i) {
+        if (static_cast<bool>(units[i].group) != static_cast<bool>(other[i].group) ||
+                units[i].text != other[i].text) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string Delta::shapeKey(const std::vector<Unit>& units) {
+    // Texts are length-prefixed, so that the key cannot be ambiguous.
+    std::string result;
+    for (auto& unit : units) {
+        if (unit.group) {
+            result += 'G';
+        } else {
+            result += 'T' + std::to_string(unit.text.length()) + ':' + unit.text;
+        }
+    }
+    return result;
+}
+
+Delta::VariantIndex Delta::indexVariants(const Group& group) {
+    VariantIndex result;
+    for (auto v : group.variants()) {
+        result.byText.emplace(v->spintaxStr(), &v->tokens());
+        result.byShape.emplace(shapeKey(units(v->tokens())), &v->tokens());
+    }
+    return result;
+}
+
+const TokVec* Delta::paired(const Variant& variant, const VariantIndex& index) {
+    auto it(index.byText.find(variant.spintaxStr()));
+    if (it != index.byText.end()) {
+        return it->second;
+    }
+
+    it = index.byShape.find(shapeKey(units(variant.tokens())));
+    if (it != index.byShape.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+Delta::Sequence Delta::align(const TokVec& tokens, const TokVec* other) {
+    Sequence result;
+    result.units = units(tokens);
+
+    std::vector<Unit> otherUnits;
+    if (other) {
+        otherUnits = units(*other);
+    }
+    result.aligned = other && alignable(result.units, otherUnits);
+
+    for (size_t i=0; i<result.units.size(); ++i) {
+        Unit& unit(result.units[i]);
+        if (unit.group) {
+            VariantIndex otherVariants;
+            if (result.aligned) {
+                otherVariants = indexVariants(*otherUnits[i].group);
+            }
+            for (auto variant : unit.group->variants()) {
+                const TokVec* counterpart(nullptr);
+                if (result.aligned) {
+                    counterpart = paired(*variant, otherVariants);
+                }
+                unit.variants.push_back(align(variant->tokens(), counterpart));
+            }
+        }
+    }
+
+    result.suffixHasAdded.assign(result.units.size() + 1, false);
+    for (size_t i=result.units.size(); i-- > 0; ) {
+        bool hasAdded(false);
+        for (auto& variant : result.units[i].variants) {
+            hasAdded = hasAdded || variant.hasAdded;
+        }
+        result.suffixHasAdded[i] = result.suffixHasAdded[i + 1] || hasAdded;
+    }
+    result.hasAdded = !result.aligned || result.suffixHasAdded[0];
+    return result;
+}
+
+bool Delta::canAdd(const std::vector<Frame>& stack) {
+    for (auto& frame : stack) {
+        if (frame.sequence->suffixHasAdded[frame.index]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+PermIndex Delta::walk(std::vector<Frame>& stack, std::string& prefix, bool added,
+        Matcher& other, const std::string& mark, std::ostream& out) {
+    // Prune paths which can only lead to permutations paired with the other version.
+    if (!added && !canAdd(stack)) {
+        return 0;
+    }
+
+    if (stack.empty()) {
+        if (!other.matches(prefix)) {
+            out << mark << prefix << '\n';
+            return 1;
+        }
+        return 0;
+    }
+
+    const size_t top(stack.size() - 1);
+    if (stack[top].index == stack[top].sequence->units.size()) {
+        const Frame frame(stack[top]);
+        stack.pop_back();
+        const PermIndex count(walk(stack, prefix, added, other, mark, out));
+        stack.push_back(frame);
+        return count;
+    }
+
+    const Unit& unit(stack[top].sequence->units[stack[top].index++]);
+    const size_t length(prefix.length());
+    PermIndex count(0);
+    if (unit.group) {
+        for (auto& variant : unit.variants) {
+            stack.push_back(Frame{&variant, 0});
+            count += walk(stack, prefix, added || !variant.aligned, other, mark, out);
+            stack.pop_back();
+        }
+    } else {
+        prefix += unit.text;
+        count = walk(stack, prefix, added, other, mark, out);
+        prefix.resize(length);
+    }
+    --stack[top].index;
+    return count;
+}
+
+PermIndex Delta::write(const Structure& structure, const Structure& other,
+        Matcher& otherMatcher, const std::string& mark, std::ostream& out) {
+    const Sequence root(align(structure.topLevelTokens(), &other.topLevelTokens()));
+    std::vector<Frame> stack(1, Frame{&root, 0});
+    std::string prefix;
+    return walk(stack, prefix, !root.aligned, otherMatcher, mark, out);
+}
+
+PermIndex Delta::writeAdded(std::ostream& out, const std::string& mark) {
+    return write(m_to, m_from, m_fromMatcher, mark, out);
+}
+
+PermIndex Delta::writeRemoved(std::ostream& out, const std::string& mark) {
+    return write(m_from, m_to, m_toMatcher, mark, out);
+}
+
+}
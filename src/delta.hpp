@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef DELTA_HPP
+#define DELTA_HPP
+
+#include "matcher.hpp"
+#include "spintax.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace spintax {
+
+//! Difference between permutations of two versions of a spintax structure.
+/*!
+ * The token sequences of both versions are aligned (equal text against
+ * equal text, group against group) and variants of aligned groups are
+ * paired with an identical or a similarly shaped variant of the other
+ * version. Only the paths through unpaired variants (or sequences that
+ * could not be aligned) are enumerated, each candidate is then verified
+ * against the other version with a Matcher. The cost is therefore
+ * proportional to the size of the difference, not to the whole output,
+ * as long as the versions share their shape.
+ *
+ * Permutations are written in the order Structure::writePermutations
+ * would write them.
+ * \sa Matcher
+ */
+class Delta {
+    struct Unit;
+
+    //! Token sequence aligned to a sequence of the other version.
+    struct Sequence {
+        std::vector<Unit>   units;
+        //! False if there is no counterpart in the other version.
+        bool                aligned;
+        //! True if any permutation may be missing in the other version.
+        bool                hasAdded;
+        //! suffixHasAdded[i] is true if any unit from i on has added permutations.
+        std::vector<bool>   suffixHasAdded;
+    };
+
+    //! Either a literal text or an expanded Group.
+    struct Unit {
+        std::string             text;
+        std::shared_ptr<Group>  group;
+        std::vector<Sequence>   variants;
+    };
+
+    struct Frame {
+        const Sequence* sequence;
+        size_t          index;
+    };
+
+    //! Variants of a group, looked up by spintax text and by shape (first one wins).
+    struct VariantIndex {
+        std::unordered_map<std::string, const TokVec*>  byText;
+        std::unordered_map<std::string, const TokVec*>  byShape;
+    };
+
+    Structure   m_from;
+    Structure   m_to;
+    Matcher     m_fromMatcher;
+    Matcher     m_toMatcher;
+
+    //! Converts tokens to units, merging adjacent literals.
+    static std::vector<Unit> units(const TokVec& tokens);
+    //! Builds the sequence of tokens, aligned to other (nullptr if none).
+    static Sequence align(const TokVec& tokens, const TokVec* other);
+    //! Checks whether units of both sequences match one to one.
+    static bool alignable(const std::vector<Unit>& units, const std::vector<Unit>& other);
+    //! Returns a key equal for two sequences of units if and only if they are alignable.
+    static std::string shapeKey(const std::vector<Unit>& units);
+    static VariantIndex indexVariants(const Group& group);
+    //! Returns tokens of the variant in index paired with variant (nullptr if none).
+    static const TokVec* paired(const Variant& variant, const VariantIndex& index);
+
+    static bool canAdd(const std::vector<Frame>& stack);
+    static PermIndex walk(std::vector<Frame>& stack, std::string& prefix, bool added,
+            Matcher& other, const std::string& mark, std::ostream& out);
+
+    static PermIndex write(const Structure& structure, const Structure& other,
+            Matcher& otherMatcher, const std::string& mark, std::ostream& out);
+
+public:
+    Delta(const Structure& from, const Structure& to);
+
+    //! Write permutations of the new version missing in the old one, each prefixed with mark.
+    /*!
+     * Returns the number of permutations written.
+     */
+    PermIndex writeAdded(std::ostream& out=std::cout, const std::string& mark="");
+    //! Write permutations of the old version missing in the new one, each prefixed with mark.
+    /*!
+     * Returns the number of permutations written.
+     */
+    PermIndex writeRemoved(std::ostream& out=std::cout, const std::string& mark="");
+};
+
+}
+
+#endif /* DELTA_HPP */
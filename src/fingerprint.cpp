@@ -0,0 +1,224 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "fingerprint.hpp"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace spintax {
+
+namespace {
+
+const unsigned long long FNV64_OFFSET       = 0xcbf29ce484222325ULL;
+const unsigned long long FNV64_PRIME        = 0x100000001b3ULL;
+const unsigned long long FNV128_OFFSET_HI   = 0x6c62272e07bb0142ULL;
+const unsigned long long FNV128_OFFSET_LO   = 0x62b821756295c58dULL;
+//! FNV-128 prime is 2^88 + FNV128_PRIME_LOW.
+const unsigned long long FNV128_PRIME_LOW   = 0x13b;
+
+//! Exclude set header is the magic (without the terminating zero) and the width byte.
+const char              EXCLUDE_MAGIC[]     = "SPINTAX";
+const size_t            EXCLUDE_MAGIC_SIZE  = sizeof(EXCLUDE_MAGIC) - 1;
+const size_t            EXCLUDE_HEADER_SIZE = EXCLUDE_MAGIC_SIZE + 1;
+
+const char              HEX_DIGITS[]        = "0123456789abcdef";
+
+void writeHexByte(std::ostream& out, unsigned char byte) {
+    out << HEX_DIGITS[byte >> 4] << HEX_DIGITS[byte & 0xf];
+}
+
+}
+
+Fingerprint::Fingerprint(unsigned bits)
+    :m_hi(0), m_lo(FNV64_OFFSET), m_bits(bits)
+{
+    if (m_bits == 128) {
+        m_hi = FNV128_OFFSET_HI;
+        m_lo = FNV128_OFFSET_LO;
+    }
+}
+
+void Fingerprint::update(const std::string& text) {
+    if (m_bits == 128) {
+        for (auto c : text) {
+            m_lo ^= static_cast<unsigned char>(c);
+            // (hi, lo) * (2^88 + FNV128_PRIME_LOW) mod 2^128
+            const unsigned long long low(m_lo & 0xffffffffULL);
+            const unsigned long long high(m_lo >> 32);
+            const unsigned long long lowProduct(low * FNV128_PRIME_LOW);
+            const unsigned long long highProduct(high * FNV128_PRIME_LOW);
+            const unsigned long long lo(lowProduct + (highProduct << 32));
+            const unsigned long long carry((highProduct >> 32) + (lo < lowProduct ? 1 : 0));
+            m_hi = m_hi * FNV128_PRIME_LOW + carry + (m_lo << 24);
+            m_lo = lo;
+        }
+    } else {
+        for (auto c : text) {
+            m_lo ^= static_cast<unsigned char>(c);
+            m_lo *= FNV64_PRIME;
+        }
+    }
+}
+
+unsigned Fingerprint::bits() const {
+    return m_bits;
+}
+
+size_t Fingerprint::size() const {
+    return m_bits / 8;
+}
+
+void Fingerprint::toBytes(unsigned char* out) const {
+    if (m_bits == 128) {
+        for (int i=0; i<8; ++i) {
+            *out++ = m_hi >> (56 - 8 * i);
+        }
+    }
+    for (int i=0; i<8; ++i) {
+        *out++ = m_lo >> (56 - 8 * i);
+    }
+}
+
+std::string Fingerprint::hex() const {
+    unsigned char bytes[16];
+    toBytes(bytes);
+    std::string result;
+    for (size_t i=0; i<size(); ++i) {
+        result += HEX_DIGITS[bytes[i] >> 4];
+        result += HEX_DIGITS[bytes[i] & 0xf];
+    }
+    return result;
+}
+
+size_t Fingerprint::writeLines(std::istream& in, std::ostream& out, unsigned bits) {
+    size_t count(0);
+    std::string line;
+    while (std::getline(in, line)) {
+        Fingerprint fingerprint(bits);
+        fingerprint.update(line);
+        out << fingerprint.hex() << '\n';
+        ++count;
+    }
+    return count;
+}
+
+ExcludeSet::ExcludeSet()
+    :m_data(nullptr), m_length(0), m_table(nullptr), m_size(0), m_bits(64)
+{
+}
+
+ExcludeSet::~ExcludeSet() {
+    close();
+}
+
+bool ExcludeSet::open(const std::string& fileName) {
+    close();
+
+    const int fd(::open(fileName.c_str(), O_RDONLY));
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(EXCLUDE_HEADER_SIZE)) {
+        ::close(fd);
+        return false;
+    }
+
+    void* data(::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0));
+    ::close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    m_data = static_cast<const unsigned char*>(data);
+    m_length = st.st_size;
+
+    const unsigned bits(m_data[EXCLUDE_MAGIC_SIZE]);
+    if (std::memcmp(m_data, EXCLUDE_MAGIC, EXCLUDE_MAGIC_SIZE) != 0 || (bits != 64 && bits != 128) ||
+            (m_length - EXCLUDE_HEADER_SIZE) % (bits / 8) != 0) {
+        close();
+        return false;
+    }
+    m_bits = bits;
+    m_table = m_data + EXCLUDE_HEADER_SIZE;
+    m_size = (m_length - EXCLUDE_HEADER_SIZE) / (bits / 8);
+    ::madvise(data, m_length, MADV_RANDOM);
+    return true;
+}
+
+void ExcludeSet::close() {
+    if (m_data) {
+        ::munmap(const_cast<unsigned char*>(m_data), m_length);
+    }
+    m_data = nullptr;
+    m_length = 0;
+    m_table = nullptr;
+    m_size = 0;
+}
+
+unsigned ExcludeSet::bits() const {
+    return m_bits;
+}
+
+size_t ExcludeSet::size() const {
+    return m_size;
+}
+
+bool ExcludeSet::contains(const Fingerprint& fingerprint) const {
+    unsigned char key[16];
+    fingerprint.toBytes(key);
+    const size_t width(m_bits / 8);
+
+    size_t first(0);
+    size_t last(size());
+    while (first < last) {
+        const size_t middle(first + (last - first) / 2);
+        const int cmp(std::memcmp(m_table + middle * width, key, width));
+        if (cmp == 0) {
+            return true;
+        } else if (cmp < 0) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return false;
+}
+
+void ExcludeSet::writeHeader(std::ostream& out, unsigned bits) {
+    out << ' ';
+    for (size_t i=0; i<EXCLUDE_MAGIC_SIZE; ++i) {
+        writeHexByte(out, EXCLUDE_MAGIC[i]);
+    }
+    writeHexByte(out, bits);
+    out << '\n';
+}
+
+}
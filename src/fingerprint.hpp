@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef FINGERPRINT_HPP
+#define FINGERPRINT_HPP
+
+#include <cstddef>
+#include <iostream>
+#include <string>
+
+namespace spintax {
+
+//! FNV-1a fingerprint of a text, 64 or 128 bits wide.
+/*!
+ * The fingerprint is updated incrementally, so a fingerprint of a prefix
+ * can be extended with the following text without hashing the prefix again.
+ */
+class Fingerprint {
+    unsigned long long  m_hi;
+    unsigned long long  m_lo;
+    unsigned            m_bits;
+
+public:
+    //! Creates a fingerprint of an empty text. Width is either 64 or 128 bits.
+    explicit Fingerprint(unsigned bits=64);
+
+    //! Appends text to the fingerprinted text.
+    void update(const std::string& text);
+
+    unsigned bits() const;
+    //! Returns number of bytes of the fingerprint.
+    size_t size() const;
+    //! Writes size() bytes of the fingerprint to out (most significant first).
+    void toBytes(unsigned char* out) const;
+    //! Returns the fingerprint as a fixed-width hexadecimal string.
+    std::string hex() const;
+
+    //! Writes hexadecimal fingerprints of each line of in (without its line break) to out.
+    /*!
+     * Lines are taken exactly as written, they are not parsed as spintax.
+     * Returns the number of lines.
+     */
+    static size_t writeLines(std::istream& in, std::ostream& out, unsigned bits=64);
+};
+
+//! Sorted table of fingerprints mapped into memory.
+/*!
+ * The file starts with a header (the "SPINTAX" magic followed by a byte
+ * holding the fingerprint width in bits), followed by fixed-width
+ * fingerprints (8 or 16 bytes, most significant byte first) sorted in
+ * ascending order. It can be created from the hexadecimal header (see
+ * writeHeader) and fingerprints with e.g.:
+ *
+ *     LC_ALL=C sort -u fingerprints.txt | xxd -r -p > exclude.bin
+ *
+ * Lookups are binary searches over the mapped file, so the table is never
+ * read into memory as a whole.
+ */
+class ExcludeSet {
+    const unsigned char*    m_data;
+    size_t                  m_length;
+    //! First fingerprint of the table (following the header).
+    const unsigned char*    m_table;
+    size_t                  m_size;
+    unsigned                m_bits;
+
+    ExcludeSet(const ExcludeSet&);
+    ExcludeSet& operator=(const ExcludeSet&);
+
+public:
+    ExcludeSet();
+    ~ExcludeSet();
+
+    //! Maps a table of fingerprints, taking their width from its header. Returns false on failure.
+    bool open(const std::string& fileName);
+    //! Unmaps the table.
+    void close();
+
+    unsigned bits() const;
+    //! Returns number of fingerprints in the table.
+    size_t size() const;
+    //! Checks whether the fingerprint is in the table (of the same width).
+    bool contains(const Fingerprint& fingerprint) const;
+
+    //! Writes the header of a table of fingerprints of the given width as a line of hexadecimal text.
+    /*!
+     * The line is indented with a space, so that it stays the first line
+     * when sorted along with the fingerprints in the C locale.
+     */
+    static void writeHeader(std::ostream& out, unsigned bits=64);
+};
+
+}
+
+#endif /* FINGERPRINT_HPP */
@@ -23,6 +23,10 @@
 // SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 //
 
+#include "analyzer.hpp"
+#include "delta.hpp"
+#include "matcher.hpp"
+#include "optimizer.hpp"
 #include "spintax.hpp"
 
 #include <boost/program_options.hpp>
@@ -38,12 +42,82 @@ using namespace spintax;
 
 namespace po = boost::program_options;
 
+//! Reads the whole template from input.
+/*!
+ * Unless keepLastBreak is set, the line break ending the template is dropped,
+ * so that permutations can be compared with single lines of text.
+ */
+std::string readTemplate(std::istream& input, bool keepLastBreak) {
+    std::string lines;
+    std::string line;
+    input >> std::noskipws;
+    while (std::getline(input, line)) {
+        lines += line + "\n";
+    }
+    if (!keepLastBreak && !lines.empty()) {
+        lines.erase(lines.size() - 1);
+    }
+    return lines;
+}
+
+//! Checks that options of only one mode are used. Prints the reason and returns false otherwise.
+bool checkOptions(const po::variables_map& vm) {
+    // Option and the mode it belongs to (generating permutations is the default mode).
+    const char* options[][2] = {
+        { "analyze",            "analyze" },
+        { "match",              "match" },
+        { "delta-from",         "delta" },
+        { "removed",            "delta" },
+        { "fingerprint-lines",  "lines" },
+        { "exclude-set",        "generate" },
+        { "no-optimize",        "generate" },
+        { "optimizer-stats",    "generate" }
+    };
+
+    const char* const* used = nullptr;
+    for (auto& option : options) {
+        if (!vm.count(option[0])) {
+            continue;
+        }
+        if (used && std::string(used[1]) != option[1]) {
+            std::cerr << "Options --" << used[0] << " and --" << option[0] <<
+                " cannot be used together." << std::endl;
+            return false;
+        }
+        used = option;
+    }
+
+    // Fingerprint width applies both to generated permutations and to plain lines.
+    if (vm.count("fingerprint") && used && std::string(used[1]) != "generate" && std::string(used[1]) != "lines") {
+        std::cerr << "Options --" << used[0] << " and --fingerprint cannot be used together." << std::endl;
+        return false;
+    }
+    if (vm.count("removed") && !vm.count("delta-from")) {
+        std::cerr << "Option --removed requires --delta-from." << std::endl;
+        return false;
+    }
+    if (vm.count("no-optimize") && vm.count("optimizer-stats")) {
+        std::cerr << "Options --no-optimize and --optimizer-stats cannot be used together." << std::endl;
+        return false;
+    }
+    return true;
+}
+
 int main(int argc, const char *argv[]) {
     po::options_description desc("Generator options");
     desc.add_options()
         ("help,h", "print this help message")
         ("input-file,i", po::value<std::string>(), "input file name (stdin is used by default)")
         ("output-file,o", po::value<std::string>(), "output file name (stdout is used by default)")
+        ("fingerprint,f", po::value<unsigned>(), "print fingerprints (FNV-1a, 64 or 128 bits wide, in hex) of permutations instead of their text")
+        ("fingerprint-lines", "print an exclude set header and fingerprints of the input lines taken as plain text (not as spintax), to build an exclude set of a published corpus")
+        ("exclude-set,x", po::value<std::string>(), "skip permutations whose fingerprints are in the given exclude set (see --fingerprint-lines), its width is used unless -f is given")
+        ("no-optimize", "generate permutations from the structure exactly as parsed")
+        ("optimizer-stats", "print number of structure nodes before and after each optimization pass to stderr")
+        ("analyze,a", "instead of generating permutations print statistics of their lengths and of the groups")
+        ("delta-from,d", po::value<std::string>(), "print only permutations of the input which are not permutations of the template in the given file")
+        ("removed,r", "with --delta-from also print permutations of the given template missing in the input (added ones are prefixed with '+', removed ones with '-')")
+        ("match,m", po::value<std::string>(), "instead of generating permutations print the index of each line of the given file that is a permutation of the input")
     ;
 
     po::variables_map vm;
@@ -58,6 +132,8 @@ int main(int argc, const char *argv[]) {
     if (vm.count("help")) {
         std::cout << desc << std::endl;
         return 1;
+    } else if (!checkOptions(vm)) {
+        return 1;
     } else {
         if (vm.count("input-file")) {
             input = new std::ifstream(vm["input-file"].as<std::string>());
@@ -69,15 +145,92 @@ int main(int argc, const char *argv[]) {
         }
     }
 
-    std::string lines;
-    std::string line;
-    *input >> std::noskipws;
-    while (std::getline(*input, line)) {
-        lines += line + "\n";
+    const unsigned bits(vm.count("fingerprint") ? vm["fingerprint"].as<unsigned>() : 64);
+    if (bits != 64 && bits != 128) {
+        std::cerr << "Fingerprints can be 64 or 128 bits wide." << std::endl;
+        return 1;
+    }
+
+    ExcludeSet exclude;
+    if (vm.count("exclude-set")) {
+        const std::string fileName(vm["exclude-set"].as<std::string>());
+        if (!exclude.open(fileName)) {
+            std::cerr << "Cannot map exclude set " << fileName << " (it has to start with the header written "
+                    "by --fingerprint-lines)." << std::endl;
+            return 1;
+        }
+        if (vm.count("fingerprint") && exclude.bits() != bits) {
+            std::cerr << "Exclude set " << fileName << " holds " << exclude.bits() << "-bit fingerprints, not "
+                    << bits << "-bit." << std::endl;
+            return 1;
+        }
+    }
+
+    if (vm.count("fingerprint-lines")) {
+        ExcludeSet::writeHeader(*output, bits);
+        Fingerprint::writeLines(*input, *output, bits);
+        if (freeInput) {
+            delete input;
+        }
+        if (freeOutput) {
+            delete output;
+        }
+        return 0;
     }
 
+    // Only plain generation keeps the line break ending the template (so each permutation is
+    // followed by a blank line). Other modes compare permutations with lines of text, -x and -f
+    // included, as fingerprints have to match those of published lines.
+    const bool plainOutput(!vm.count("match") && !vm.count("analyze") && !vm.count("delta-from") &&
+            !vm.count("fingerprint") && !vm.count("exclude-set"));
+    const std::string lines(readTemplate(*input, plainOutput));
+
     Parser parser;
-    parser.parse(lines).writePermutations(*output);
+    if (vm.count("delta-from")) {
+        std::ifstream fromInput(vm["delta-from"].as<std::string>());
+        if (!fromInput) {
+            std::cerr << "Cannot open template " << vm["delta-from"].as<std::string>() << "." << std::endl;
+            return 1;
+        }
+        Parser fromParser;
+        Delta delta(fromParser.parse(readTemplate(fromInput, false)), parser.parse(lines));
+        if (vm.count("removed")) {
+            delta.writeAdded(*output, "+");
+            delta.writeRemoved(*output, "-");
+        } else {
+            delta.writeAdded(*output);
+        }
+    } else if (vm.count("analyze")) {
+        Analyzer analyzer(parser.parse(lines));
+        analyzer.writeReport(*output);
+    } else if (vm.count("match")) {
+        std::ifstream candidates(vm["match"].as<std::string>());
+        if (!candidates) {
+            std::cerr << "Cannot open candidates " << vm["match"].as<std::string>() << "." << std::endl;
+            return 1;
+        }
+        Matcher matcher(parser.parse(lines));
+        matcher.writeMatches(candidates, *output);
+    } else {
+        Structure structure(parser.parse(lines));
+        if (!vm.count("no-optimize")) {
+            Optimizer optimizer;
+            structure = optimizer.optimize(structure);
+            if (vm.count("optimizer-stats")) {
+                optimizer.writeStats(std::cerr);
+            }
+        }
+
+        if (vm.count("fingerprint") && vm.count("exclude-set")) {
+            structure.writeFingerprints(*output, exclude);
+        } else if (vm.count("fingerprint")) {
+            structure.writeFingerprints(*output, bits);
+        } else if (vm.count("exclude-set")) {
+            structure.writePermutations(*output, exclude);
+        } else {
+            structure.writePermutations(*output);
+        }
+    }
 
     if (freeInput) {
         delete input;
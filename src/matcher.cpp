@@ -0,0 +1,281 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "matcher.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace spintax {
+
+const size_t Matcher::MAX_DFA_STATES;
+const int    Matcher::DFA_UNKNOWN;
+const int    Matcher::DFA_DEAD;
+const unsigned Matcher::NO_CHOICE;
+
+Matcher::Matcher(const Structure& structure)
+    :m_generation(0), m_indexFits(true)
+{
+    // If the total fits, so do the counts of all subtrees and every index.
+    try {
+        structure.numPermutations();
+    } catch (const std::overflow_error&) {
+        m_indexFits = false;
+    }
+
+    compile(structure.topLevelTokens(), 1);
+    emit(Inst::Match);
+    m_marks.resize(m_program.size(), 0);
+}
+
+unsigned Matcher::emit(Inst::Op op) {
+    Inst inst;
+    inst.op = op;
+    inst.c = 0;
+    inst.next = m_program.size() + 1;
+    m_program.push_back(inst);
+    return m_program.size() - 1;
+}
+
+void Matcher::compile(const TokVec& tokens, PermIndex weight) {
+    // The permutation index is a mixed radix number, so a variant chosen in a
+    // group adds the permutations of the variants before it times the weight
+    // of the group (the number of permutations of all tokens following it).
+    std::vector<PermIndex> weights(tokens.size(), weight);
+    if (m_indexFits) {
+        for (size_t i=tokens.size(); i-- > 1; ) {
+            weights[i - 1] = weights[i] * tokens[i]->numPermutations();
+        }
+    }
+
+    for (size_t i=0; i<tokens.size(); ++i) {
+        const std::shared_ptr<Token>& token(tokens[i]);
+        const std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            const unsigned fork(emit(Inst::Fork));
+            std::vector<unsigned> jumps;
+            PermIndex offset(0);
+            for (auto variant : group->variants()) {
+                m_program[fork].targets.push_back(m_program.size());
+                m_program[fork].offsets.push_back(offset);
+                if (m_indexFits) {
+                    offset += variant->numPermutations() * weights[i];
+                }
+                compile(variant->tokens(), weights[i]);
+                jumps.push_back(emit(Inst::Jump));
+            }
+            for (auto jump : jumps) {
+                m_program[jump].next = m_program.size();
+            }
+        } else {
+            for (auto c : token->str()) {
+                m_program[emit(Inst::Char)].c = c;
+            }
+        }
+    }
+}
+
+void Matcher::nextGeneration() {
+    if (++m_generation == 0) {
+        std::fill(m_marks.begin(), m_marks.end(), 0);
+        m_generation = 1;
+    }
+}
+
+void Matcher::closure(unsigned pc, std::vector<unsigned>& pcs) {
+    // Explicit stack, as templates may chain any number of forks and jumps.
+    std::vector<unsigned> stack(1, pc);
+    while (!stack.empty()) {
+        pc = stack.back();
+        stack.pop_back();
+        if (m_marks[pc] == m_generation) {
+            continue;
+        }
+        m_marks[pc] = m_generation;
+
+        const Inst& inst(m_program[pc]);
+        if (inst.op == Inst::Fork) {
+            stack.insert(stack.end(), inst.targets.begin(), inst.targets.end());
+        } else if (inst.op == Inst::Jump) {
+            stack.push_back(inst.next);
+        } else {
+            pcs.push_back(pc);
+        }
+    }
+}
+
+int Matcher::dfaState(std::vector<unsigned>& pcs) {
+    if (pcs.empty()) {
+        return DFA_DEAD;
+    }
+    std::sort(pcs.begin(), pcs.end());
+
+    auto it(m_dfaIds.find(pcs));
+    if (it != m_dfaIds.end()) {
+        return it->second;
+    }
+
+    DfaState state;
+    state.pcs = pcs;
+    state.accepting = m_program[pcs.back()].op == Inst::Match;
+    std::fill(state.next, state.next + 256, DFA_UNKNOWN);
+
+    const int id(m_dfa.size());
+    m_dfa.push_back(state);
+    m_dfaIds[pcs] = id;
+    return id;
+}
+
+int Matcher::dfaStep(int state, unsigned char c) {
+    int next(m_dfa[state].next[c]);
+    if (next != DFA_UNKNOWN) {
+        return next;
+    }
+
+    std::vector<unsigned> pcs;
+    nextGeneration();
+    for (auto pc : m_dfa[state].pcs) {
+        const Inst& inst(m_program[pc]);
+        if (inst.op == Inst::Char && inst.c == c) {
+            closure(inst.next, pcs);
+        }
+    }
+    next = dfaState(pcs);
+    m_dfa[state].next[c] = next;
+    return next;
+}
+
+bool Matcher::matches(const std::string& text) {
+    if (m_dfa.size() > MAX_DFA_STATES) {
+        m_dfa.clear();
+        m_dfaIds.clear();
+    }
+
+    if (m_dfa.empty()) {
+        std::vector<unsigned> pcs;
+        nextGeneration();
+        closure(0, pcs);
+        dfaState(pcs);
+    }
+
+    int state(0);
+    for (auto c : text) {
+        state = dfaStep(state, c);
+        if (state == DFA_DEAD) {
+            return false;
+        }
+    }
+    return m_dfa[state].accepting;
+}
+
+void Matcher::addThread(std::vector<Thread>& threads, unsigned pc, unsigned choice) {
+    // Explicit stack, as templates may chain any number of forks and jumps. Fork targets
+    // are pushed in reverse, so that they are visited in priority order.
+    m_stack.clear();
+    m_stack.push_back(Thread{pc, choice});
+    while (!m_stack.empty()) {
+        const Thread thread(m_stack.back());
+        m_stack.pop_back();
+        if (m_marks[thread.pc] == m_generation) {
+            continue;
+        }
+        m_marks[thread.pc] = m_generation;
+
+        const Inst& inst(m_program[thread.pc]);
+        if (inst.op == Inst::Fork) {
+            for (size_t i=inst.targets.size(); i-- > 0; ) {
+                m_choices.push_back(Choice{thread.pc, static_cast<unsigned>(i), thread.choice});
+                m_stack.push_back(Thread{inst.targets[i], static_cast<unsigned>(m_choices.size() - 1)});
+            }
+        } else if (inst.op == Inst::Jump) {
+            m_stack.push_back(Thread{inst.next, thread.choice});
+        } else {
+            threads.push_back(thread);
+        }
+    }
+}
+
+bool Matcher::match(const std::string& text, MatchResult& result) {
+    if (!matches(text)) {
+        return false;
+    }
+
+    // Threads are kept in priority order, so the first one to reach Match
+    // carries the lowest choices (hence the lowest permutation index).
+    m_choices.clear();
+    m_threads.clear();
+    nextGeneration();
+    addThread(m_threads, 0, NO_CHOICE);
+
+    for (auto c : text) {
+        m_nextThreads.clear();
+        nextGeneration();
+        for (auto& thread : m_threads) {
+            const Inst& inst(m_program[thread.pc]);
+            if (inst.op == Inst::Char && inst.c == static_cast<unsigned char>(c)) {
+                addThread(m_nextThreads, inst.next, thread.choice);
+            }
+        }
+        m_threads.swap(m_nextThreads);
+    }
+
+    for (auto& thread : m_threads) {
+        if (m_program[thread.pc].op == Inst::Match) {
+            result.choices.clear();
+            result.hasIndex = m_indexFits;
+            result.index = 0;
+            for (unsigned i=thread.choice; i != NO_CHOICE; i=m_choices[i].prev) {
+                const Choice& choice(m_choices[i]);
+                result.choices.push_back(choice.variant);
+                if (m_indexFits) {
+                    result.index += m_program[choice.fork].offsets[choice.variant];
+                }
+            }
+            std::reverse(result.choices.begin(), result.choices.end());
+            return true;
+        }
+    }
+    return false;
+}
+
+PermIndex Matcher::writeMatches(std::istream& in, std::ostream& out) {
+    PermIndex count(0);
+    MatchResult result;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (match(line, result)) {
+            if (result.hasIndex) {
+                out << result.index;
+            } else {
+                out << '-';
+            }
+            out << '\t' << line << '\n';
+            ++count;
+        }
+    }
+    return count;
+}
+
+}
@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef MATCHER_HPP
+#define MATCHER_HPP
+
+#include "spintax.hpp"
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace spintax {
+
+//! Details of a successful Matcher::match.
+struct MatchResult {
+    //! Variant index chosen in each expanded Group, in the order they appear in the output.
+    std::vector<unsigned>   choices;
+    //! False if the structure has too many permutations to index them with PermIndex.
+    bool                    hasIndex;
+    //! Position of the matched text in the Structure::writePermutations output (if hasIndex).
+    PermIndex               index;
+};
+
+//! Spintax matcher.
+/*!
+ * Checks whether a string is one of the permutations of a Structure
+ * without generating them. The structure is compiled into an NFA
+ * (one state per literal character, with a fork per Group); membership
+ * is answered by a lazily built DFA in time linear in the input length,
+ * and the choices leading to a match are recovered by a Pike VM simulation
+ * of the NFA, run only for the strings that matched.
+ *
+ * When a string can be produced in several ways (e.g. "{a|a}") the lowest
+ * permutation index is reported.
+ *
+ * This object is not thread-safe (the DFA is cached internally), it is
+ * suggested to use a separate instance of Matcher in each thread.
+ * \sa Structure
+ */
+class Matcher {
+    struct Inst {
+        enum Op {
+            Char,
+            Fork,
+            Jump,
+            Match
+        };
+
+        Op                      op;
+        unsigned char           c;
+        //! Jump target or the first target of a fork.
+        unsigned                next;
+        //! Fork targets, one per Group variant.
+        std::vector<unsigned>   targets;
+        //! Permutation index offset of each fork target (if m_indexFits).
+        std::vector<PermIndex>  offsets;
+    };
+
+    //! Maximum number of cached DFA states before the cache is flushed.
+    static const size_t MAX_DFA_STATES = 4096;
+    static const int    DFA_UNKNOWN = -1;
+    static const int    DFA_DEAD    = -2;
+
+    struct DfaState {
+        std::vector<unsigned>   pcs;
+        bool                    accepting;
+        int                     next[256];
+    };
+
+    static const unsigned NO_CHOICE = static_cast<unsigned>(-1);
+
+    //! Fork taken by a Pike VM thread, linked to the previous one (or NO_CHOICE).
+    struct Choice {
+        unsigned    fork;
+        unsigned    variant;
+        unsigned    prev;
+    };
+
+    struct Thread {
+        unsigned    pc;
+        //! Last choice made by this thread, an index into m_choices.
+        unsigned    choice;
+    };
+
+    std::vector<Inst>                       m_program;
+    std::vector<DfaState>                   m_dfa;
+    std::map<std::vector<unsigned>, int>    m_dfaIds;
+    std::vector<unsigned>                   m_marks;
+    unsigned                                m_generation;
+    //! True if the number of permutations fits PermIndex.
+    bool                                    m_indexFits;
+    //! Choices made by all threads of the current match (shared tails).
+    std::vector<Choice>                     m_choices;
+    std::vector<Thread>                     m_threads;
+    std::vector<Thread>                     m_nextThreads;
+    std::vector<Thread>                     m_stack;
+
+    unsigned emit(Inst::Op op);
+    //! Compiles tokens whose next permutation digit is weight indices apart.
+    void compile(const TokVec& tokens, PermIndex weight);
+
+    //! Adds the epsilon closure of pc to pcs.
+    void closure(unsigned pc, std::vector<unsigned>& pcs);
+    void nextGeneration();
+    int dfaState(std::vector<unsigned>& pcs);
+    int dfaStep(int state, unsigned char c);
+
+    //! Adds a Pike VM thread for pc (following forks and jumps in priority order).
+    void addThread(std::vector<Thread>& threads, unsigned pc, unsigned choice);
+
+public:
+    explicit Matcher(const Structure& structure);
+
+    //! Checks whether text is one of the permutations.
+    bool matches(const std::string& text);
+    //! Checks whether text is one of the permutations and fills result if so.
+    bool match(const std::string& text, MatchResult& result);
+
+    //! Matches each line of in, writing "<index>\t<line>" to out for those that match.
+    /*!
+     * The index is written as "-" if it does not fit PermIndex.
+     * Returns the number of matching lines.
+     */
+    PermIndex writeMatches(std::istream& in, std::ostream& out);
+};
+
+}
+
+#endif /* MATCHER_HPP */
@@ -0,0 +1,363 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "optimizer.hpp"
+
+#include <stdexcept>
+
+namespace spintax {
+
+namespace {
+
+//! Returns all permutations of tokens (in the Structure::writePermutations order).
+StrVec expand(const TokVec& tokens) {
+    StrVec result(1);
+    for (auto token : tokens) {
+        const std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            StrVec perGroup;
+            for (auto variant : group->variants()) {
+                StrVec perVariant(expand(variant->tokens()));
+                std::copy(perVariant.begin(), perVariant.end(), std::back_inserter(perGroup));
+            }
+            StrVec mixed;
+            for (auto& prefix : result) {
+                for (auto& suffix : perGroup) {
+                    mixed.push_back(prefix + suffix);
+                }
+            }
+            result.swap(mixed);
+        } else {
+            for (auto& prefix : result) {
+                prefix += token->str();
+            }
+        }
+    }
+    return result;
+}
+
+//! Returns number of permutations of token, or the maximum PermIndex if it does not fit.
+PermIndex boundedPermutations(const std::shared_ptr<Token>& token) {
+    try {
+        return token->numPermutations();
+    } catch (const std::overflow_error&) {
+        return static_cast<PermIndex>(-1);
+    }
+}
+
+//! Returns average number of nodes visited per permutation of tokens and sets count to their number.
+double visitedNodes(const TokVec& tokens, long double& count) {
+    double result(0);
+    count = 1;
+    for (auto token : tokens) {
+        ++result;
+        const std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            // The variant node and its tokens, weighted by how often the variant is used.
+            long double total(0);
+            long double weighted(0);
+            for (auto variant : group->variants()) {
+                long double variantCount(0);
+                const double nodes(visitedNodes(variant->tokens(), variantCount));
+                total += variantCount;
+                weighted += variantCount * (1 + nodes);
+            }
+            result += weighted / total;
+            count *= total;
+        }
+    }
+    return result;
+}
+
+//! Returns a variant consisting of a single simple token (or an empty one).
+std::shared_ptr<Variant> textVariant(const std::string& text) {
+    std::shared_ptr<Variant> variant(new Variant);
+    if (!text.empty()) {
+        variant->addToken(std::shared_ptr<Simple>(new Simple(text)));
+    }
+    return variant;
+}
+
+}
+
+OptimizerPass::~OptimizerPass() {
+}
+
+std::shared_ptr<Group> OptimizerPass::runOnVariants(const Group& group) const {
+    std::shared_ptr<Group> result(new Group);
+    for (auto v : group.variants()) {
+        std::shared_ptr<Variant> variant(new Variant);
+        for (auto t : run(v->tokens())) {
+            variant->addToken(t);
+        }
+        result->addVariant(variant);
+    }
+    return result;
+}
+
+std::string InlineSingleVariantGroups::name() const {
+    return "inline-single-variant-groups";
+}
+
+TokVec InlineSingleVariantGroups::run(const TokVec& tokens) const {
+    TokVec result;
+    for (auto token : tokens) {
+        std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            result.push_back(runOnVariants(*group));
+        } else if (std::dynamic_pointer_cast<Group>(token)) {
+            // Structure::writePermutations outputs such groups as plain text.
+            const std::string text(token->str());
+            if (!text.empty()) {
+                result.push_back(std::shared_ptr<Simple>(new Simple(text)));
+            }
+        } else {
+            result.push_back(token);
+        }
+    }
+    return result;
+}
+
+FlattenSmallGroups::FlattenSmallGroups(PermIndex maxTableSize)
+    :m_maxTableSize(maxTableSize)
+{
+}
+
+std::string FlattenSmallGroups::name() const {
+    return "flatten-small-groups";
+}
+
+TokVec FlattenSmallGroups::run(const TokVec& tokens) const {
+    TokVec result;
+    TokVec tokensRun;
+    PermIndex runSize(1);
+    bool runHasGroup(false);
+    bool runIsNested(false);
+
+    auto flush = [&]() {
+        if (runHasGroup && (tokensRun.size() > 1 || runIsNested)) {
+            std::shared_ptr<Group> table(new Group);
+            for (auto& text : expand(tokensRun)) {
+                table->addVariant(textVariant(text));
+            }
+            result.push_back(table);
+        } else {
+            std::copy(tokensRun.begin(), tokensRun.end(), std::back_inserter(result));
+        }
+        tokensRun.clear();
+        runSize = 1;
+        runHasGroup = false;
+        runIsNested = false;
+    };
+
+    for (auto token : tokens) {
+        std::shared_ptr<Group> group(expandedGroup(token));
+        const PermIndex size(boundedPermutations(token));
+        if (size > m_maxTableSize / runSize) {
+            flush();
+        }
+
+        if (size > m_maxTableSize) {
+            result.push_back(group ? runOnVariants(*group) : token);
+            continue;
+        }
+
+        tokensRun.push_back(token);
+        runSize *= size;
+        if (group) {
+            runHasGroup = true;
+            for (auto variant : group->variants()) {
+                for (auto t : variant->tokens()) {
+                    runIsNested = runIsNested || expandedGroup(t);
+                }
+            }
+        }
+    }
+    flush();
+    return result;
+}
+
+std::string FactorCommonAffixes::name() const {
+    return "factor-common-affixes";
+}
+
+TokVec FactorCommonAffixes::run(const TokVec& tokens) const {
+    TokVec result;
+    for (auto token : tokens) {
+        std::shared_ptr<Group> group(expandedGroup(token));
+        if (!group) {
+            result.push_back(token);
+            continue;
+        }
+        group = runOnVariants(*group);
+
+        // Leading and trailing text of each variant (empty if it starts or ends with a group).
+        std::vector<TokVec> variants;
+        for (auto variant : group->variants()) {
+            variants.push_back(variant->tokens());
+        }
+        auto literal = [](const TokVec& variant, bool front) {
+            if (variant.empty()) {
+                return std::string();
+            }
+            const std::shared_ptr<Token>& edge(front ? variant.front() : variant.back());
+            return expandedGroup(edge) ? std::string() : edge->str();
+        };
+
+        std::string prefix(literal(variants.front(), true));
+        for (auto& variant : variants) {
+            const std::string text(literal(variant, true));
+            prefix.erase(std::mismatch(prefix.begin(), prefix.end(), text.begin(), text.end()).first, prefix.end());
+        }
+        if (!prefix.empty()) {
+            for (auto& variant : variants) {
+                const std::string text(literal(variant, true).substr(prefix.length()));
+                variant.erase(variant.begin());
+                if (!text.empty()) {
+                    variant.insert(variant.begin(), std::shared_ptr<Simple>(new Simple(text)));
+                }
+            }
+        }
+
+        std::string suffix(literal(variants.front(), false));
+        for (auto& variant : variants) {
+            const std::string text(literal(variant, false));
+            suffix.erase(suffix.begin(), std::mismatch(suffix.rbegin(), suffix.rend(), text.rbegin(), text.rend()).first.base());
+        }
+        if (!suffix.empty()) {
+            for (auto& variant : variants) {
+                const std::string text(literal(variant, false));
+                variant.pop_back();
+                if (text.length() > suffix.length()) {
+                    variant.push_back(std::shared_ptr<Simple>(new Simple(text.substr(0, text.length() - suffix.length()))));
+                }
+            }
+        }
+
+        if (!prefix.empty()) {
+            result.push_back(std::shared_ptr<Simple>(new Simple(prefix)));
+        }
+        std::shared_ptr<Group> factored(new Group);
+        for (auto& variantTokens : variants) {
+            std::shared_ptr<Variant> variant(new Variant);
+            for (auto t : variantTokens) {
+                variant->addToken(t);
+            }
+            factored->addVariant(variant);
+        }
+        result.push_back(factored);
+        if (!suffix.empty()) {
+            result.push_back(std::shared_ptr<Simple>(new Simple(suffix)));
+        }
+    }
+    return result;
+}
+
+std::string MergeSimples::name() const {
+    return "merge-simples";
+}
+
+TokVec MergeSimples::run(const TokVec& tokens) const {
+    TokVec result;
+    std::string text;
+    for (auto token : tokens) {
+        std::shared_ptr<Group> group(expandedGroup(token));
+        if (!group) {
+            text += token->str();
+            continue;
+        }
+        if (!text.empty()) {
+            result.push_back(std::shared_ptr<Simple>(new Simple(text)));
+            text.clear();
+        }
+        result.push_back(runOnVariants(*group));
+    }
+    if (!text.empty()) {
+        result.push_back(std::shared_ptr<Simple>(new Simple(text)));
+    }
+    return result;
+}
+
+const PermIndex Optimizer::DEFAULT_MAX_TABLE_SIZE;
+
+Optimizer::Optimizer(PermIndex maxTableSize) {
+    addPass(std::shared_ptr<OptimizerPass>(new InlineSingleVariantGroups));
+    addPass(std::shared_ptr<OptimizerPass>(new MergeSimples));
+    addPass(std::shared_ptr<OptimizerPass>(new FactorCommonAffixes));
+    addPass(std::shared_ptr<OptimizerPass>(new MergeSimples));
+    addPass(std::shared_ptr<OptimizerPass>(new FlattenSmallGroups(maxTableSize)));
+}
+
+void Optimizer::addPass(const std::shared_ptr<OptimizerPass>& pass) {
+    m_passes.push_back(pass);
+}
+
+void Optimizer::clear() {
+    m_passes.clear();
+}
+
+Structure Optimizer::optimize(const Structure& structure) {
+    TokVec tokens(structure.topLevelTokens());
+    m_stats.clear();
+    m_stats.push_back(Stats{"input", numNodes(tokens), nodesPerPermutation(tokens)});
+    for (auto pass : m_passes) {
+        tokens = pass->run(tokens);
+        m_stats.push_back(Stats{pass->name(), numNodes(tokens), nodesPerPermutation(tokens)});
+    }
+
+    Structure result;
+    for (auto t : tokens) {
+        result.addTopLevel(t);
+    }
+    return result;
+}
+
+void Optimizer::writeStats(std::ostream& out) const {
+    for (auto& stats : m_stats) {
+        out << stats.name << ": " << stats.numNodes << " nodes, "
+            << stats.nodesPerPermutation << " visited per permutation\n";
+    }
+}
+
+unsigned Optimizer::numNodes(const TokVec& tokens) {
+    unsigned result(0);
+    for (auto token : tokens) {
+        ++result;
+        std::shared_ptr<Group> group(std::dynamic_pointer_cast<Group>(token));
+        if (group) {
+            for (auto variant : group->variants()) {
+                result += 1 + numNodes(variant->tokens());
+            }
+        }
+    }
+    return result;
+}
+
+double Optimizer::nodesPerPermutation(const TokVec& tokens) {
+    long double count(0);
+    return visitedNodes(tokens, count);
+}
+
+}
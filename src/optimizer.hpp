@@ -0,0 +1,139 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+#include "spintax.hpp"
+
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace spintax {
+
+//! Single rewrite of the spintax tree.
+/*!
+ * Passes never modify the tokens they are given, rewritten parts of the
+ * tree are built anew (unchanged subtrees may be shared). Each pass has to
+ * preserve the permutations and their order exactly.
+ * \sa Optimizer
+ */
+class OptimizerPass {
+protected:
+    //! Returns a copy of group with run() applied to each of its variants.
+    std::shared_ptr<Group> runOnVariants(const Group& group) const;
+
+public:
+    virtual ~OptimizerPass() = 0;
+
+    //! Returns name of this pass.
+    virtual std::string name() const = 0;
+    //! Returns tokens rewritten by this pass.
+    virtual TokVec run(const TokVec& tokens) const = 0;
+};
+
+//! Replaces groups with less than 2 variants with their text.
+class InlineSingleVariantGroups : public OptimizerPass {
+public:
+    std::string name() const;
+    TokVec run(const TokVec& tokens) const;
+};
+
+//! Replaces runs of tokens with few permutations with a single group of plain variants.
+/*!
+ * E.g. "{a|b} x {c|{d|e}}" becomes "{a x c|a x d|a x e|b x c|b x d|b x e}"
+ * if maxTableSize allows for 6 variants.
+ */
+class FlattenSmallGroups : public OptimizerPass {
+    PermIndex m_maxTableSize;
+
+public:
+    explicit FlattenSmallGroups(PermIndex maxTableSize);
+
+    std::string name() const;
+    TokVec run(const TokVec& tokens) const;
+};
+
+//! Moves text common to the beginning (or the end) of all variants in front of (or behind) the group.
+class FactorCommonAffixes : public OptimizerPass {
+public:
+    std::string name() const;
+    TokVec run(const TokVec& tokens) const;
+};
+
+//! Joins adjacent simple tokens.
+class MergeSimples : public OptimizerPass {
+public:
+    std::string name() const;
+    TokVec run(const TokVec& tokens) const;
+};
+
+//! Spintax structure optimizer.
+/*!
+ * Runs a pipeline of passes over a Structure, so that generating its
+ * permutations visits fewer tokens. Note that flattening small groups
+ * trades a bigger tree for fewer nodes visited per permutation. The optimized structure generates
+ * exactly the same permutations in the same order.
+ * \sa OptimizerPass, Structure
+ */
+class Optimizer {
+    std::vector<std::shared_ptr<OptimizerPass>>     m_passes;
+    struct Stats {
+        std::string name;
+        unsigned    numNodes;
+        double      nodesPerPermutation;
+    };
+
+    std::vector<Stats>                              m_stats;
+
+public:
+    //! Default maximum number of variants of a group built by FlattenSmallGroups.
+    static const PermIndex DEFAULT_MAX_TABLE_SIZE = 64;
+
+    //! Creates the default pipeline.
+    explicit Optimizer(PermIndex maxTableSize=DEFAULT_MAX_TABLE_SIZE);
+
+    //! Appends a pass to the pipeline.
+    void addPass(const std::shared_ptr<OptimizerPass>& pass);
+    //! Removes all passes from the pipeline.
+    void clear();
+
+    //! Returns structure rewritten by all passes of the pipeline.
+    Structure optimize(const Structure& structure);
+
+    //! Write number of nodes before and after each pass of the last optimize() call.
+    void writeStats(std::ostream& out=std::cerr) const;
+
+    //! Returns number of nodes (groups, variants and simple tokens) of tokens.
+    static unsigned numNodes(const TokVec& tokens);
+    //! Returns average number of nodes visited while generating a single permutation of tokens.
+    static double nodesPerPermutation(const TokVec& tokens);
+};
+
+}
+
+#endif /* OPTIMIZER_HPP */
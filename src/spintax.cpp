@@ -25,10 +25,30 @@
 
 #include "spintax.hpp"
 
+#include <stdexcept>
+
 namespace spintax
 {
 
-inline Token::~Token()
+namespace {
+
+PermIndex checkedAdd(PermIndex a, PermIndex b) {
+    if (a + b < a) {
+        throw std::overflow_error("Too many permutations to index.");
+    }
+    return a + b;
+}
+
+PermIndex checkedMultiply(PermIndex a, PermIndex b) {
+    if (b != 0 && a > static_cast<PermIndex>(-1) / b) {
+        throw std::overflow_error("Too many permutations to index.");
+    }
+    return a * b;
+}
+
+}
+
+Token::~Token()
 {
 }
 
@@ -36,6 +56,10 @@ unsigned Token::numVariants() const {
     return 0;
 }
 
+PermIndex Token::numPermutations() const {
+    return 1;
+}
+
 Variant::~Variant() {
     for(auto t : m_tokens) {
         t.reset();
@@ -62,10 +86,26 @@ std::string Variant::structureAsStr(const std::string& prefix) const {
     return result;
 }
 
+std::string Variant::spintaxStr() const {
+    std::string result;
+    for (auto t : m_tokens) {
+        result += t->spintaxStr();
+    }
+    return result;
+}
+
 unsigned Variant::numVariants() const {
     return m_tokens.size();
 }
 
+PermIndex Variant::numPermutations() const {
+    PermIndex result(1);
+    for (auto t : m_tokens) {
+        result = checkedMultiply(result, t->numPermutations());
+    }
+    return result;
+}
+
 std::shared_ptr<Token> Variant::token(int index) {
     return m_tokens[index];
 }
@@ -104,10 +144,33 @@ std::string Group::structureAsStr(const std::string& prefix) const {
     return result;
 }
 
+std::string Group::spintaxStr() const {
+    std::string result(1, Parser::GROUP_START);
+    for (size_t i=0; i<m_variants.size(); ++i) {
+        if (i > 0) {
+            result += Parser::VARIANT_SEP;
+        }
+        result += m_variants[i]->spintaxStr();
+    }
+    return result + Parser::GROUP_END;
+}
+
 unsigned Group::numVariants() const {
     return m_variants.size();
 }
 
+PermIndex Group::numPermutations() const {
+    // Mirrors Structure::writePermutations, which expands single variant groups as plain text.
+    if (numVariants() < 2) {
+        return 1;
+    }
+    PermIndex result(0);
+    for (auto v : m_variants) {
+        result = checkedAdd(result, v->numPermutations());
+    }
+    return result;
+}
+
 std::shared_ptr<Variant> Group::variant(int index) {
     return m_variants[index];
 }
@@ -129,11 +192,21 @@ std::string Simple::structureAsStr(const std::string& prefix) const {
     return prefix + "S: '" + m_str + "'\n";
 }
 
+std::string Simple::spintaxStr() const {
+    return m_str;
+}
 
 unsigned Simple::numVariants() const {
     return 1;
 }
 
+std::shared_ptr<Group> expandedGroup(const std::shared_ptr<Token>& token) {
+    if (token->numVariants() > 1) {
+        return std::dynamic_pointer_cast<Group>(token);
+    }
+    return std::shared_ptr<Group>();
+}
+
 Structure::~Structure() {
     for (auto t : m_topLevelTokens) {
         t.reset();
@@ -146,6 +219,18 @@ void Structure::writeStructure(std::ostream& out) const {
     }
 }
 
+PermIndex Structure::numPermutations() const {
+    PermIndex result(1);
+    for (auto t : m_topLevelTokens) {
+        result = checkedMultiply(result, t->numPermutations());
+    }
+    return result;
+}
+
+const TokVec& Structure::topLevelTokens() const {
+    return m_topLevelTokens;
+}
+
 void Structure::addTopLevel(const std::shared_ptr<Token>& token) {
     m_topLevelTokens.push_back(token);
 }
@@ -163,24 +248,92 @@ void Structure::writePermutations(std::ostream& out) const {
 
 void Structure::writePermutations(StrVec& res, const TokVec& tokens) const {
     for (auto token : tokens) {
-        if (token->numVariants() > 1) {
-            std::shared_ptr<Group> group(std::dynamic_pointer_cast<Group>(token));
-            if (group) {
-                StrVec perGroup;
-                for (auto variant : group->variants()) {
-                    StrVec perVariant;
-                    perVariant.push_back(std::string());
-                    writePermutations(perVariant, variant->tokens());
-                    std::copy(perVariant.begin(), perVariant.end(), std::back_inserter(perGroup));
-                }
-                mix(res, perGroup);
+        std::shared_ptr<Group> group(expandedGroup(token));
+        if (group) {
+            StrVec perGroup;
+            for (auto variant : group->variants()) {
+                StrVec perVariant;
+                perVariant.push_back(std::string());
+                writePermutations(perVariant, variant->tokens());
+                std::copy(perVariant.begin(), perVariant.end(), std::back_inserter(perGroup));
             }
+            mix(res, perGroup);
         } else {
             addToAll(res, token->str());
         }
     }
 }
 
+void Structure::writePermutations(std::ostream& out, const ExcludeSet& exclude) const {
+    forEachPermutation([&out, &exclude](const std::string* text, const Fingerprint& fingerprint) {
+        if (!exclude.contains(fingerprint)) {
+            out << *text << '\n';
+        }
+    }, exclude.bits());
+}
+
+void Structure::writeFingerprints(std::ostream& out, unsigned bits) const {
+    writeFingerprints(out, bits, nullptr);
+}
+
+void Structure::writeFingerprints(std::ostream& out, const ExcludeSet& exclude) const {
+    writeFingerprints(out, exclude.bits(), &exclude);
+}
+
+void Structure::writeFingerprints(std::ostream& out, unsigned bits, const ExcludeSet* exclude) const {
+    forEachPermutation([&out, exclude](const std::string*, const Fingerprint& fingerprint) {
+        if (!exclude || !exclude->contains(fingerprint)) {
+            out << fingerprint.hex() << '\n';
+        }
+    }, bits, false);
+}
+
+void Structure::forEachPermutation(const PermutationVisitor& visitor, unsigned bits, bool withText) const {
+    std::vector<Frame> stack(1, Frame{&m_topLevelTokens, 0});
+    std::string text;
+    walkPermutations(stack, withText ? &text : nullptr, Fingerprint(bits), visitor);
+}
+
+void Structure::walkPermutations(std::vector<Frame>& stack, std::string* text,
+        const Fingerprint& fingerprint, const PermutationVisitor& visitor) const {
+    if (stack.empty()) {
+        visitor(text, fingerprint);
+        return;
+    }
+
+    const size_t top(stack.size() - 1);
+    if (stack[top].index == stack[top].tokens->size()) {
+        const Frame frame(stack[top]);
+        stack.pop_back();
+        walkPermutations(stack, text, fingerprint, visitor);
+        stack.push_back(frame);
+        return;
+    }
+
+    const std::shared_ptr<Token>& token((*stack[top].tokens)[stack[top].index++]);
+    const std::shared_ptr<Group> group(expandedGroup(token));
+    if (group) {
+        for (auto variant : group->variants()) {
+            stack.push_back(Frame{&variant->tokens(), 0});
+            walkPermutations(stack, text, fingerprint, visitor);
+            stack.pop_back();
+        }
+    } else {
+        const std::string str(token->str());
+        Fingerprint extended(fingerprint);
+        extended.update(str);
+        if (text) {
+            const size_t length(text->length());
+            *text += str;
+            walkPermutations(stack, text, extended, visitor);
+            text->resize(length);
+        } else {
+            walkPermutations(stack, text, extended, visitor);
+        }
+    }
+    --stack[top].index;
+}
+
 void Structure::mix(StrVec& res, StrVec& variants) const {
     const auto lengthRes(res.size());
     const auto lengthVariants(variants.size());
@@ -27,8 +27,10 @@
 #define SPINTAX_H
 
 #include "errors.hpp"
+#include "fingerprint.hpp"
 
 #include <algorithm>
+#include <functional>
 #include <iostream>
 #include <iterator>
 #include <memory>
@@ -45,6 +47,9 @@ typedef std::vector<std::string>                StrVec;
 typedef std::vector<std::shared_ptr<Token>>     TokVec;
 typedef std::vector<std::shared_ptr<Variant>>   VarVec;
 
+//! Index of a single permutation (and the type used for permutation counts).
+typedef unsigned long long                      PermIndex;
+
 //! Basic spintax entity - token.
 /*!
  * It is a base class for each spintax framework classes.
@@ -57,9 +62,16 @@ public:
     virtual std::string str() const = 0;
     //! Returns string representing structure of this token.
     virtual std::string structureAsStr(const std::string& prefix) const = 0;
+    //! Returns spintax text of this token (as it would be parsed).
+    virtual std::string spintaxStr() const = 0;
 
     //! Returns number of child entities of this token.
     virtual unsigned numVariants() const;
+    //! Returns number of permutations generated for this token.
+    /*!
+     * Throws std::overflow_error if the number does not fit PermIndex.
+     */
+    virtual PermIndex numPermutations() const;
 };
 
 //! Single spintax group variant.
@@ -77,8 +89,10 @@ public:
 
     std::string str() const;
     std::string structureAsStr(const std::string& prefix) const;
+    std::string spintaxStr() const;
 
     unsigned numVariants() const;
+    PermIndex numPermutations() const;
     //! Adds a child token to this variant.
     void addToken(const std::shared_ptr<Token>& token);
     //! Returns a child token of this variant at index.
@@ -100,9 +114,11 @@ public:
 
     std::string str() const;
     std::string structureAsStr(const std::string& prefix) const;
+    std::string spintaxStr() const;
 
     std::shared_ptr<Variant> lastVariant();
     unsigned numVariants() const;
+    PermIndex numPermutations() const;
     //! Adds a variant to this group (inserts at the end).
     void addVariant(const std::shared_ptr<Variant>& variant);
     //! Get a variant of this group at index.
@@ -125,10 +141,17 @@ public:
 
     std::string str() const;
     std::string structureAsStr(const std::string& prefix) const;
+    std::string spintaxStr() const;
 
     unsigned numVariants() const;
 };
 
+//! Returns token as a Group if it is expanded into variants, nullptr otherwise.
+/*!
+ * A group with a single variant is not expanded, its str() is used as is.
+ */
+std::shared_ptr<Group> expandedGroup(const std::shared_ptr<Token>& token);
+
 //! Spintax structure.
 /*!
  * Contains parsed information on the spintax structure,
@@ -137,6 +160,16 @@ public:
  * \sa Parser
  */
 class Structure {
+public:
+    //! Function called for each permutation with its text (nullptr if not requested) and fingerprint.
+    typedef std::function<void(const std::string*, const Fingerprint&)> PermutationVisitor;
+
+private:
+    struct Frame {
+        const TokVec*   tokens;
+        size_t          index;
+    };
+
     TokVec m_topLevelTokens;
 
     //! Mixes the output vector with variants generated.
@@ -149,6 +182,12 @@ class Structure {
     //! Adds str at the end of each elements of res.
     virtual void addToAll(StrVec& res, const std::string& str) const;
 
+    //! Visits permutations of the remaining tokens on stack, extending text and fingerprint.
+    void walkPermutations(std::vector<Frame>& stack, std::string* text,
+            const Fingerprint& fingerprint, const PermutationVisitor& visitor) const;
+    //! Write fingerprints of permutations which are not excluded (exclude may be nullptr).
+    void writeFingerprints(std::ostream& out, unsigned bits, const ExcludeSet* exclude) const;
+
 protected:
     //! Write all permutations of provided tokens to res.
     void writePermutations(StrVec& res, const TokVec& tokens) const;
@@ -160,6 +199,28 @@ public:
 
     //! Write all permutations of this structure to the provided output stream.
     void writePermutations(std::ostream& out=std::cout) const;
+    //! Write permutations of this structure whose fingerprints are not in exclude.
+    void writePermutations(std::ostream& out, const ExcludeSet& exclude) const;
+    //! Write fingerprints (in hex, one per line) of all permutations of this structure.
+    void writeFingerprints(std::ostream& out, unsigned bits=64) const;
+    //! Write fingerprints of permutations of this structure which are not in exclude.
+    void writeFingerprints(std::ostream& out, const ExcludeSet& exclude) const;
+
+    //! Calls visitor for each permutation, in the writePermutations order.
+    /*!
+     * Permutations are built incrementally, each token is appended to the text
+     * (only if withText is set) and the fingerprint of the prefix it follows.
+     */
+    void forEachPermutation(const PermutationVisitor& visitor, unsigned bits=64,
+            bool withText=true) const;
+
+    //! Returns the number of permutations of this structure.
+    /*!
+     * Throws std::overflow_error if the number does not fit PermIndex.
+     */
+    PermIndex numPermutations() const;
+    //! Returns all top level tokens of this structure.
+    const TokVec& topLevelTokens() const;
 
     //! Adds a top level token to this structure.
     void addTopLevel(const std::shared_ptr<Token>& token);
@@ -178,10 +239,12 @@ public:
  * \sa Structure
  */
 class Parser {
+public:
     static const char GROUP_START = '{';
     static const char GROUP_END   = '}';
     static const char VARIANT_SEP = '|';
 
+private:
     static ConsoleErrorHandler defaultErrorHandler;
 
     std::stack<std::shared_ptr<Group>>  m_groups;
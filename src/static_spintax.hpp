@@ -0,0 +1,321 @@
+//
+// Copyright (c) 2013 Dariusz Gadomski <dgadomski@gmail.com>
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+//
+//  * Redistributions of source code must retain the above copyright notice, this
+// list of conditions and the following disclaimer.
+//  * Redistributions in binary form must reproduce the above copyright notice,
+// this list of conditions and the following disclaimer in the documentation and/or
+// other materials provided with the distribution.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS ``AS IS''
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+// DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+// ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+// (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+// LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+// ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+// (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+// SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef STATIC_SPINTAX_HPP
+#define STATIC_SPINTAX_HPP
+
+#include "spintax.hpp"
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace spintax {
+
+//! Single node of a StaticStructure node table.
+/*!
+ * Nodes refer to each other by their index in the table. Simple nodes
+ * keep a [begin, end) range of the template text, Variant and Group
+ * nodes keep a singly linked list of their children.
+ * \sa StaticStructure
+ */
+struct StaticNode {
+    enum Kind {
+        SimpleNode,
+        VariantNode,
+        GroupNode
+    };
+
+    static const std::size_t npos = static_cast<std::size_t>(-1);
+
+    Kind        kind;
+    std::size_t begin;
+    std::size_t end;
+    std::size_t firstChild;
+    std::size_t lastChild;
+    std::size_t nextSibling;
+    //! Number of permutations this node expands to.
+    PermIndex   count;
+
+    constexpr StaticNode()
+        :kind(SimpleNode), begin(0), end(0), firstChild(npos), lastChild(npos),
+        nextSibling(npos), count(1)
+    {
+    }
+};
+
+//! Compile-time spintax structure.
+/*!
+ * Counterpart of Parser and Structure for templates known at compile time.
+ * The template is parsed by the constexpr constructor into a fixed-size
+ * node table, with the permutation count of every node computed up front.
+ * Declaring the object constexpr turns malformed templates (brackets
+ * mismatch, variant separator outside of a group, group with less than
+ * 2 variants, too many permutations to index) into compile errors.
+ *
+ * Permutations are indexed in the order Structure::writePermutations
+ * writes them, so permutation(i) is the i-th line of its output.
+ *
+ * \code
+ * constexpr auto tpl = spintax::makeStatic("{Hello|Hi} {world|there}!");
+ * static_assert(tpl.count() == 4, "");
+ * tpl.writePermutations(std::cout);
+ * \endcode
+ * \sa makeStatic, Structure
+ */
+template<std::size_t N>
+class StaticStructure {
+public:
+    //! Upper bound on the number of nodes a template of length N - 1 needs.
+    static const std::size_t MAX_NODES = 2 * N + 1;
+
+private:
+    static const char GROUP_START = '{';
+    static const char GROUP_END   = '}';
+    static const char VARIANT_SEP = '|';
+
+    char        m_text[N];
+    StaticNode  m_nodes[MAX_NODES];
+    std::size_t m_numNodes;
+
+    constexpr std::size_t addNode(StaticNode::Kind kind, std::size_t parent) {
+        const std::size_t index(m_numNodes++);
+        m_nodes[index].kind = kind;
+        if (m_nodes[parent].lastChild == StaticNode::npos) {
+            m_nodes[parent].firstChild = index;
+        } else {
+            m_nodes[m_nodes[parent].lastChild].nextSibling = index;
+        }
+        m_nodes[parent].lastChild = index;
+        return index;
+    }
+
+    constexpr void addSimple(std::size_t begin, std::size_t end, std::size_t parent) {
+        if (begin < end) {
+            const std::size_t index(addNode(StaticNode::SimpleNode, parent));
+            m_nodes[index].begin = begin;
+            m_nodes[index].end = end;
+        }
+    }
+
+    //! Computes permutation counts bottom-up (children always follow their parents).
+    constexpr void computeCounts() {
+        for (std::size_t i=m_numNodes; i-- > 0; ) {
+            StaticNode& node(m_nodes[i]);
+            if (node.kind == StaticNode::SimpleNode) {
+                continue;
+            }
+            PermIndex total(node.kind == StaticNode::GroupNode ? 0 : 1);
+            for (std::size_t c=node.firstChild; c != StaticNode::npos; c=m_nodes[c].nextSibling) {
+                const PermIndex childCount(m_nodes[c].count);
+                if (node.kind == StaticNode::GroupNode) {
+                    if (total + childCount < total) {
+                        throw std::overflow_error("Too many permutations to index.");
+                    }
+                    total += childCount;
+                } else {
+                    if (total > static_cast<PermIndex>(-1) / childCount) {
+                        throw std::overflow_error("Too many permutations to index.");
+                    }
+                    total *= childCount;
+                }
+            }
+            node.count = total;
+        }
+    }
+
+    void appendPermutation(std::size_t index, PermIndex perm, std::string& out) const {
+        const StaticNode& node(m_nodes[index]);
+        if (node.kind == StaticNode::SimpleNode) {
+            out.append(m_text + node.begin, node.end - node.begin);
+        } else if (node.kind == StaticNode::GroupNode) {
+            std::size_t c(node.firstChild);
+            while (perm >= m_nodes[c].count) {
+                perm -= m_nodes[c].count;
+                c = m_nodes[c].nextSibling;
+            }
+            appendPermutation(c, perm, out);
+        } else {
+            // The first token is the most significant digit.
+            PermIndex divisor(node.count);
+            for (std::size_t c=node.firstChild; c != StaticNode::npos; c=m_nodes[c].nextSibling) {
+                divisor /= m_nodes[c].count;
+                appendPermutation(c, perm / divisor, out);
+                perm %= divisor;
+            }
+        }
+    }
+
+    //! Depth-first walk over the node table, extending buffer in place.
+    /*!
+     * Each stack entry is the next node to emit in a variant that is still
+     * being expanded, or npos once that variant is exhausted.
+     */
+    template<typename F>
+    void walkPermutations(std::vector<std::size_t>& stack, std::string& buffer, F& f) const {
+        if (stack.empty()) {
+            f(static_cast<const std::string&>(buffer));
+            return;
+        }
+
+        const std::size_t top(stack.size() - 1);
+        const std::size_t index(stack[top]);
+        if (index == StaticNode::npos) {
+            stack.pop_back();
+            walkPermutations(stack, buffer, f);
+            stack.push_back(index);
+            return;
+        }
+
+        const StaticNode& node(m_nodes[index]);
+        stack[top] = node.nextSibling;
+        if (node.kind == StaticNode::SimpleNode) {
+            const std::size_t length(buffer.length());
+            buffer.append(m_text + node.begin, node.end - node.begin);
+            walkPermutations(stack, buffer, f);
+            buffer.resize(length);
+        } else {
+            for (std::size_t c=node.firstChild; c != StaticNode::npos; c=m_nodes[c].nextSibling) {
+                stack.push_back(m_nodes[c].firstChild);
+                walkPermutations(stack, buffer, f);
+                stack.pop_back();
+            }
+        }
+        stack[top] = index;
+    }
+
+public:
+    //! Parses the template. Throws std::logic_error on malformed input.
+    constexpr explicit StaticStructure(const char (&input)[N])
+        :m_text(), m_nodes(), m_numNodes(1)
+    {
+        m_nodes[0].kind = StaticNode::VariantNode;
+
+        std::size_t groups[N] = {};
+        std::size_t depth(0);
+        std::size_t simpleStart(0);
+
+        for (std::size_t i=0; i+1<N; ++i) {
+            const char c(input[i]);
+            m_text[i] = c;
+            if (c != GROUP_START && c != GROUP_END && c != VARIANT_SEP) {
+                continue;
+            }
+
+            const std::size_t current(depth == 0 ? 0 : m_nodes[groups[depth - 1]].lastChild);
+            addSimple(simpleStart, i, current);
+            simpleStart = i + 1;
+
+            if (c == GROUP_START) {
+                const std::size_t group(addNode(StaticNode::GroupNode, current));
+                addNode(StaticNode::VariantNode, group);
+                groups[depth++] = group;
+            } else if (c == GROUP_END) {
+                if (depth == 0) {
+                    throw std::logic_error("Closing group that was not opened. Brackets mismatch.");
+                }
+                const StaticNode& group(m_nodes[groups[--depth]]);
+                if (group.firstChild == group.lastChild) {
+                    // Parser only warns about these and expands them as plain text.
+                    throw std::logic_error("Group with less than 2 variants.");
+                }
+            } else {
+                if (depth == 0) {
+                    throw std::logic_error("Variant separator outside of a group.");
+                }
+                addNode(StaticNode::VariantNode, groups[depth - 1]);
+            }
+        }
+
+        if (depth != 0) {
+            throw std::logic_error("Brackets mismatch: group(s) have not been closed.");
+        }
+        addSimple(simpleStart, N - 1, 0);
+
+        computeCounts();
+    }
+
+    //! Returns the number of permutations of this template.
+    constexpr PermIndex count() const {
+        return m_nodes[0].count;
+    }
+
+    //! Returns the number of used entries of the node table (root included).
+    constexpr std::size_t numNodes() const {
+        return m_numNodes;
+    }
+
+    //! Returns the node at index (0 is the root Variant).
+    constexpr const StaticNode& node(std::size_t index) const {
+        return m_nodes[index];
+    }
+
+    //! Appends the permutation with index perm (< count()) to out.
+    void permutation(PermIndex perm, std::string& out) const {
+        appendPermutation(0, perm, out);
+    }
+
+    //! Returns the permutation with index perm (< count()).
+    std::string permutation(PermIndex perm) const {
+        std::string result;
+        permutation(perm, result);
+        return result;
+    }
+
+    //! Calls f with each permutation in order.
+    /*!
+     * The string passed to f is reused between calls.
+     */
+    template<typename F>
+    void forEachPermutation(F f) const {
+        std::string buffer;
+        std::vector<std::size_t> stack;
+        stack.reserve(m_numNodes);
+        stack.push_back(m_nodes[0].firstChild);
+        walkPermutations(stack, buffer, f);
+    }
+
+    //! Write all permutations to the provided output stream, one per line.
+    void writePermutations(std::ostream& out=std::cout) const {
+        forEachPermutation([&out](const std::string& perm) {
+            out << perm << '\n';
+        });
+    }
+};
+
+template<std::size_t N>
+const std::size_t StaticStructure<N>::MAX_NODES;
+
+//! Creates a StaticStructure from a string literal.
+template<std::size_t N>
+constexpr StaticStructure<N> makeStatic(const char (&input)[N]) {
+    return StaticStructure<N>(input);
+}
+
+}
+
+#endif /* STATIC_SPINTAX_HPP */
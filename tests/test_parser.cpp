@@ -24,12 +24,21 @@
 //
 
 #include <cassert>
+#include <cmath>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 #include <vector>
 
+#include <unistd.h>
+
+#include <analyzer.hpp>
+#include <delta.hpp>
+#include <matcher.hpp>
+#include <optimizer.hpp>
 #include <spintax.hpp>
+#include <static_spintax.hpp>
 
 #include <boost/test/parameterized_test.hpp>
 #include <boost/test/included/unit_test.hpp>
@@ -53,6 +62,283 @@ void test_data(const std::pair<std::string, size_t>& data) {
     BOOST_CHECK_EQUAL(result, data.second);
 }
 
+void test_static() {
+    constexpr auto tpl = makeStatic("{a|b{c|d|}} and {e|f}{|!}");
+    static_assert(tpl.count() == 16, "wrong static permutation count");
+
+    std::ostringstream expected;
+    Parser parser;
+    parser.parse("{a|b{c|d|}} and {e|f}{|!}").writePermutations(expected);
+
+    std::ostringstream actual;
+    tpl.writePermutations(actual);
+    BOOST_CHECK_EQUAL(actual.str(), expected.str());
+    BOOST_CHECK_EQUAL(tpl.permutation(5), "bc and e!");
+
+    // Not constexpr, so the template is rejected at run time rather than at compile time.
+    BOOST_CHECK_THROW(makeStatic("x{a{b|c}}y"), std::logic_error);
+    BOOST_CHECK_THROW(makeStatic("x{}y"), std::logic_error);
+}
+
+void test_matcher() {
+    Parser parser;
+    const Structure& structure(parser.parse("{a|b{c|d|}} and {e|f}{|!}"));
+    std::ostringstream permutations;
+    structure.writePermutations(permutations);
+
+    Matcher matcher(structure);
+    MatchResult result;
+    std::istringstream lines(permutations.str());
+    std::string line;
+    PermIndex index(0);
+    while (std::getline(lines, line)) {
+        BOOST_CHECK(matcher.match(line, result));
+        BOOST_CHECK_EQUAL(result.index, index++);
+    }
+
+    BOOST_CHECK(matcher.match("bd and f", result));
+    BOOST_CHECK(result.choices == std::vector<unsigned>({1, 1, 1, 0}));
+    BOOST_CHECK(!matcher.matches("bd and f!!"));
+    BOOST_CHECK(!matcher.matches("b and"));
+    BOOST_CHECK(!matcher.matches(""));
+
+    // 2^64 permutations are one too many to index.
+    std::string huge;
+    for (int i=0; i<64; ++i) {
+        huge += "{a|b}";
+    }
+    BOOST_CHECK_THROW(parser.parse(huge).numPermutations(), std::overflow_error);
+    Matcher hugeMatcher(parser.parse(huge));
+    BOOST_CHECK(hugeMatcher.match("b" + std::string(63, 'a'), result));
+    BOOST_CHECK(!result.hasIndex);
+    BOOST_CHECK_EQUAL(result.choices.size(), 64);
+    BOOST_CHECK_EQUAL(result.choices.front(), 1);
+
+    // 2^63 permutations still fit.
+    Matcher fitMatcher(parser.parse(huge.substr(5)));
+    BOOST_CHECK(fitMatcher.match(std::string(63, 'b'), result));
+    BOOST_CHECK(result.hasIndex);
+    BOOST_CHECK_EQUAL(result.index, static_cast<PermIndex>(-1) / 2);
+
+    // Long chains of forks must not exhaust the stack.
+    std::string chain;
+    for (int i=0; i<50000; ++i) {
+        chain += "{a|}";
+    }
+    Matcher chainMatcher(parser.parse(chain));
+    BOOST_CHECK(chainMatcher.match("aaa", result));
+    BOOST_CHECK_EQUAL(result.choices.size(), 50000);
+    BOOST_CHECK_EQUAL(result.choices[2], 0);
+    BOOST_CHECK_EQUAL(result.choices[3], 1);
+    BOOST_CHECK(!chainMatcher.matches("aab"));
+}
+
+void test_analyzer() {
+    Parser parser;
+    const Structure& structure(parser.parse("{a|b{c|d|}} and {e|ff}{|!}"));
+    std::ostringstream permutations;
+    structure.writePermutations(permutations);
+
+    LengthHistogram expected;
+    std::istringstream lines(permutations.str());
+    std::string line;
+    while (std::getline(lines, line)) {
+        expected.resize(std::max(expected.size(), line.length() + 1), 0.0L);
+        ++expected[line.length()];
+    }
+
+    Analyzer analyzer(structure);
+    BOOST_CHECK(analyzer.histogram() == expected);
+    BOOST_CHECK_EQUAL(analyzer.numPermutations(), 16);
+    BOOST_CHECK_EQUAL(analyzer.minLength(), 7);
+    BOOST_CHECK_EQUAL(analyzer.maxLength(), 10);
+    BOOST_CHECK_EQUAL(analyzer.percentile(50), 8);
+    BOOST_REQUIRE_EQUAL(analyzer.groups().size(), 4);
+    BOOST_CHECK_EQUAL(analyzer.groups()[1].depth, 1);
+    BOOST_CHECK_EQUAL(analyzer.groups()[1].lines, 12);
+
+    // 2^64 permutations (one more than PermIndex can count), split by the outer group.
+    std::string half;
+    for (int i=0; i<63; ++i) {
+        half += "{a|b}";
+    }
+    const long double twoTo64(std::ldexp(1.0L, 64));
+    Analyzer boundary(parser.parse("{" + half + "|" + half + "}"));
+    BOOST_CHECK(boundary.numPermutations() == twoTo64);
+    BOOST_CHECK(boundary.histogram()[63] == twoTo64);
+    BOOST_CHECK_EQUAL(boundary.meanLength(), 63);
+    BOOST_CHECK(boundary.groups()[1].lines == twoTo64 / 2);
+    std::ostringstream report;
+    boundary.writeReport(report);
+    BOOST_CHECK(report.str().find("permutations: 18446744073709551616\n") != std::string::npos);
+
+    Analyzer huge(parser.parse(half + half));
+    BOOST_CHECK(huge.numPermutations() == std::ldexp(1.0L, 126));
+    BOOST_CHECK_EQUAL(huge.meanLength(), 126);
+    BOOST_CHECK_EQUAL(huge.percentile(50), 126);
+}
+
+StrVec permutations(const std::string& input) {
+    Parser parser;
+    std::ostringstream ostr;
+    parser.parse(input).writePermutations(ostr);
+    std::istringstream lines(ostr.str());
+    StrVec result;
+    std::string line;
+    while (std::getline(lines, line)) {
+        result.push_back(line);
+    }
+    return result;
+}
+
+void test_delta_case(const std::string& from, const std::string& to) {
+    const StrVec fromPerms(permutations(from));
+    const StrVec toPerms(permutations(to));
+    std::ostringstream expected;
+    for (auto p : toPerms) {
+        if (std::find(fromPerms.begin(), fromPerms.end(), p) == fromPerms.end()) {
+            expected << "+" << p << "\n";
+        }
+    }
+    for (auto p : fromPerms) {
+        if (std::find(toPerms.begin(), toPerms.end(), p) == toPerms.end()) {
+            expected << "-" << p << "\n";
+        }
+    }
+
+    Parser fromParser;
+    Parser toParser;
+    Delta delta(fromParser.parse(from), toParser.parse(to));
+    std::ostringstream actual;
+    delta.writeAdded(actual, "+");
+    delta.writeRemoved(actual, "-");
+    BOOST_CHECK_EQUAL(actual.str(), expected.str());
+}
+
+void test_delta() {
+    test_delta_case("{a|b{c|d}} and {e|f}", "{a|b{c|d|x}} and {e|f}");
+    test_delta_case("{a|b{c|d}} and {e|f}", "{a|y|b{c|d}} and {f|g}");
+    test_delta_case("{a|b{c|d}} and {e|f}", "{a|bc|bd} and {e|f}!");
+    test_delta_case("{a|b}", "{a|b}");
+}
+
+void test_optimizer_case(const std::string& input, PermIndex maxTableSize) {
+    Parser parser;
+    const Structure& structure(parser.parse(input));
+    std::ostringstream expected;
+    structure.writePermutations(expected);
+
+    Optimizer optimizer(maxTableSize);
+    const Structure optimized(optimizer.optimize(structure));
+    std::ostringstream actual;
+    optimized.writePermutations(actual);
+    BOOST_CHECK_EQUAL(actual.str(), expected.str());
+    if (maxTableSize > 0) {
+        BOOST_CHECK(Optimizer::nodesPerPermutation(optimized.topLevelTokens()) <
+                Optimizer::nodesPerPermutation(structure.topLevelTokens()));
+    }
+}
+
+void test_optimizer() {
+    const char* inputs[] = {
+        "{a|b{c|d|}} and {e|f}{|!}",
+        "{the cat|the dog|the cow} {sat|sat down|sat {here|there}} {x}{}{y{a|b}}.",
+        "{ab|abab|ab}{aa|a}{x|x}",
+        "{article directories|blogs|web2|weblogs} are {a {fantastic|great|wonderful} and "
+            "{important|critical} {element|component|aspect} of SEO|useful for {getting|gaining} backlinks}."
+    };
+    for (auto input : inputs) {
+        test_optimizer_case(input, 0);
+        test_optimizer_case(input, 8);
+        test_optimizer_case(input, Optimizer::DEFAULT_MAX_TABLE_SIZE);
+    }
+}
+
+void test_fingerprints() {
+    Parser parser;
+    const Structure& structure(parser.parse("{a|b{c|d|}} and {e|f}{|!}"));
+    const StrVec expected(permutations("{a|b{c|d|}} and {e|f}{|!}"));
+
+    for (unsigned bits : {64, 128}) {
+        StrVec texts;
+        structure.forEachPermutation([&texts, bits](const std::string* text, const Fingerprint& fingerprint) {
+            Fingerprint whole(bits);
+            whole.update(*text);
+            BOOST_CHECK_EQUAL(fingerprint.hex(), whole.hex());
+            texts.push_back(*text);
+        }, bits);
+        BOOST_CHECK(texts == expected);
+    }
+
+    Fingerprint fingerprint(128);
+    fingerprint.update("a");
+    BOOST_CHECK_EQUAL(fingerprint.hex(), "d228cb696f1a8caf78912b704e4a8964");
+}
+
+void test_exclude_set() {
+    const StrVec all(permutations("{a|b{c|d|}} and {e|f}{|!}"));
+
+    // Every third permutation is "published", with a line containing spintax syntax.
+    std::ostringstream published;
+    std::ostringstream expected;
+    size_t numPublished(1);
+    for (size_t i=0; i<all.size(); ++i) {
+        (i % 3 == 0 ? published : expected) << all[i] << "\n";
+        numPublished += i % 3 == 0;
+    }
+    published << "{a|b} and e\n";
+
+    for (unsigned bits : {64, 128}) {
+        std::istringstream lines(published.str());
+        std::ostringstream hex;
+        ExcludeSet::writeHeader(hex, bits);
+        BOOST_CHECK_EQUAL(Fingerprint::writeLines(lines, hex, bits), numPublished);
+
+        StrVec fingerprints;
+        std::istringstream hexLines(hex.str());
+        std::string line;
+        while (std::getline(hexLines, line)) {
+            fingerprints.push_back(line);
+        }
+        // The indented header sorts first.
+        std::sort(fingerprints.begin(), fingerprints.end());
+        BOOST_REQUIRE_EQUAL(fingerprints.front()[0], ' ');
+
+        char fileName[] = "/tmp/spintax-exclude-XXXXXX";
+        const int fd(mkstemp(fileName));
+        BOOST_REQUIRE(fd >= 0);
+        close(fd);
+        ExcludeSet exclude;
+        for (bool withHeader : {false, true}) {
+            std::ofstream table(fileName, std::ios::binary);
+            for (auto& f : fingerprints) {
+                const size_t start(f.find_first_not_of(' '));
+                if (start > 0 && !withHeader) {
+                    continue;
+                }
+                for (size_t i=start; i<f.length(); i+=2) {
+                    table.put(static_cast<char>(std::stoi(f.substr(i, 2), nullptr, 16)));
+                }
+            }
+            table.close();
+            BOOST_CHECK_EQUAL(exclude.open(fileName), withHeader);
+        }
+        BOOST_CHECK_EQUAL(exclude.bits(), bits);
+        BOOST_CHECK_EQUAL(exclude.size(), fingerprints.size() - 1);
+        Fingerprint spintax(bits);
+        spintax.update("{a|b} and e");
+        BOOST_CHECK(exclude.contains(spintax));
+
+        Parser parser;
+        std::ostringstream actual;
+        parser.parse("{a|b{c|d|}} and {e|f}{|!}").writePermutations(actual, exclude);
+        BOOST_CHECK_EQUAL(actual.str(), expected.str());
+
+        exclude.close();
+        unlink(fileName);
+    }
+}
+
 test_suite *init_unit_test_suite(int argc, char *argv[]) {
     test_suite *ts = BOOST_TEST_SUITE("parser");
     std::vector<std::pair<std::string, size_t> > params;
@@ -65,6 +351,13 @@ test_suite *init_unit_test_suite(int argc, char *argv[]) {
 
     }
     ts->add(BOOST_PARAM_TEST_CASE(&test_data, params.begin(), params.end()));
+    ts->add(BOOST_TEST_CASE(&test_static));
+    ts->add(BOOST_TEST_CASE(&test_matcher));
+    ts->add(BOOST_TEST_CASE(&test_analyzer));
+    ts->add(BOOST_TEST_CASE(&test_delta));
+    ts->add(BOOST_TEST_CASE(&test_optimizer));
+    ts->add(BOOST_TEST_CASE(&test_fingerprints));
+    ts->add(BOOST_TEST_CASE(&test_exclude_set));
     return ts;
 }
 